@@ -1,22 +1,32 @@
 #include "action.hh"
 
-MyActionInitialization::MyActionInitialization()
+MyActionInitialization::MyActionInitialization(MyDetectorConstruction* detectorConstruction)
+    : fDetectorConstruction(detectorConstruction)
 {}
 
 MyActionInitialization::~MyActionInitialization()
 {}
 
-//void MyActionInitialization::BuildForMaster() const
-//{
-//	MyRunAction* runAction = new MyRunAction();
-//	SetUserAction(runAction);
-//}
+void MyActionInitialization::BuildForMaster() const
+{
+	MyRunAction* runAction = new MyRunAction(fDetectorConstruction);
+	SetUserAction(runAction);
+}
 void MyActionInitialization::Build() const
 {
 	MyPrimaryGenerator* generator = new MyPrimaryGenerator();
 	SetUserAction(generator);
 
-	//MyRunAction* runAction = new MyRunAction();
-	//SetUserAction(runAction);
+	MyRunAction* runAction = new MyRunAction(fDetectorConstruction);
+	SetUserAction(runAction);
+
+	MyStackingAction* stackingAction = new MyStackingAction(runAction);
+	SetUserAction(stackingAction);
+
+	MyEventAction* eventAction = new MyEventAction(runAction);
+	SetUserAction(eventAction);
+
+	MySteppingAction* steppingAction = new MySteppingAction(runAction, eventAction, stackingAction, fDetectorConstruction);
+	SetUserAction(steppingAction);
 }
 
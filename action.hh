@@ -4,18 +4,23 @@
 #include "G4VUserActionInitialization.hh"
 
 #include "generator.hh"
-//#include "run.hh"
-//#include "event.hh"
-//#include "stepping.hh"
+#include "construction.hh"
+#include "run.hh"
+#include "event.hh"
+#include "stacking.hh"
+#include "stepping.hh"
 
 class MyActionInitialization : public G4VUserActionInitialization
 {
 public:
-    MyActionInitialization();
+    MyActionInitialization(MyDetectorConstruction*);
     ~MyActionInitialization();
 
-    /*virtual void BuildForMaster() const;*/
+    virtual void BuildForMaster() const;
     virtual void Build() const;
+
+private:
+    MyDetectorConstruction* fDetectorConstruction;
 };
 
 #endif
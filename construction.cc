@@ -6,6 +6,7 @@
 #include "G4NistManager.hh"
 #include "G4VisAttributes.hh"
 #include <cmath>
+#include <algorithm>
 #include <vector>
 #include <fstream>
 #include <iomanip>
@@ -16,28 +17,66 @@
 #include "physics.hh"
 #include "G4UserLimits.hh"
 #include "G4GDMLParser.hh"
-
-// Constants for the gold block and detector
-const double goldBlockThickness = 0.1 * um; // Thickness of the gold block
-const double goldBlockWidth = 0.1 * m;      // Width of the gold block
-const double goldBlockHeight = 0.1 * m;     // Height of the gold block
-const double detectorThickness = 0.01 * m;  // Thickness of the detector
-const double detectorRadius = 0.05 * m;     // Radius of the detector
-const double detectorXPosition = 0.8 * m;   // Position of the detector along the z-axis
-
-MyDetectorConstruction::MyDetectorConstruction() : G4VUserDetectorConstruction() {
-    // Constructor implementation (if needed)
+#include "G4RunManager.hh"
+#include "G4SDManager.hh"
+#include "G4GeometryManager.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4SolidStore.hh"
+#include "G4NavigationHistory.hh"
+#include "G4AffineTransform.hh"
+
+MyDetectorConstruction::MyDetectorConstruction()
+    : G4VUserDetectorConstruction(),
+      logicDetector(nullptr),
+      logicGoldBlock(nullptr),
+      logicGoldSkin(nullptr),
+      logicSubstrate(nullptr),
+      fMessenger(nullptr),
+      fGeometryMessenger(nullptr),
+      fCoatingMaterial("G4_Au"),
+      fSubstrateMaterial("G4_Ni"),
+      fCoatingThickness(0.1 * um),
+      fSkinThickness(0.02 * um),
+      fSkinMaxStep(0.00001 * mm),
+      fBulkMaxStep(0.),
+      fSubstrateThickness(0.),
+      fUniformStepLimit(false),
+      fGoldBlockWidth(0.1 * m),       // Width of the gold block
+      fGoldBlockHeight(0.1 * m),      // Height of the gold block
+      fDetectorThickness(0.01 * m),   // Thickness of the detector
+      fDetectorRadius(0.05 * m),      // Radius of the detector
+      fDetectorXPosition(0.8 * m),    // Distance of the detector along the -x axis
+      fConstructTime(0.),
+      fConstructCount(0),
+      fGeometryRebuilt(false)
+{
+    DefineCommands();
 }
 
 MyDetectorConstruction::~MyDetectorConstruction() {
-    // Destructor implementation (if needed)
+    delete fMessenger;
+    delete fGeometryMessenger;
 }
 
 G4VPhysicalVolume* MyDetectorConstruction::Construct() {
+    // Overlaps are not checked per placement; see MyOverlapValidator
+
+    // Start of a (re)build, the run action measures the re-initialization from here
+    fConstructStart = std::chrono::steady_clock::now();
+
+    // Clean up a previous geometry when rebuilding between runs
+    G4GeometryManager::GetInstance()->OpenGeometry();
+    G4PhysicalVolumeStore::GetInstance()->Clean();
+    G4LogicalVolumeStore::GetInstance()->Clean();
+    G4SolidStore::GetInstance()->Clean();
+    logicGoldSkin = nullptr;
+    logicSubstrate = nullptr;
+
     G4NistManager* nist = G4NistManager::Instance();
 
     // Define materials
-    G4Material* gold = nist->FindOrBuildMaterial("G4_Au");
+    G4Material* coating = nist->FindOrBuildMaterial(fCoatingMaterial);
     G4Material* worldMat = nist->FindOrBuildMaterial("G4_Galactic"); // Use vacuum instead of air
     G4Material* silicon = nist->FindOrBuildMaterial("G4_Si");
 
@@ -48,20 +87,48 @@ G4VPhysicalVolume* MyDetectorConstruction::Construct() {
 
     G4Box* solidWorld = new G4Box("solidWorld", xWorld, yWorld, zWorld);
     G4LogicalVolume* logicWorld = new G4LogicalVolume(solidWorld, worldMat, "logicWorld");
-    G4VPhysicalVolume* physWorld = new G4PVPlacement(0, G4ThreeVector(0., 0., 0.), logicWorld, "physWorld", 0, false, 0, true);
+    G4VPhysicalVolume* physWorld = new G4PVPlacement(0, G4ThreeVector(0., 0., 0.), logicWorld, "physWorld", 0, false, 0, false);
 
     // Add a step limiter to the vacuum (world volume)
     G4double maxStepVacuum = 0.1 * mm; // Set a maximum step size for the vacuum
     logicWorld->SetUserLimits(new G4UserLimits(maxStepVacuum));
 
-    // Place the gold block
-    G4Box* solidGoldBlock = new G4Box("solidGoldBlock", goldBlockWidth / 2, goldBlockThickness / 2, goldBlockHeight / 2);
-    G4LogicalVolume* logicGoldBlock = new G4LogicalVolume(solidGoldBlock, gold, "logicGoldBlock");
-    new G4PVPlacement(0, G4ThreeVector(0., -goldBlockThickness / 2, 0.), logicGoldBlock, "physGoldBlock", logicWorld, false, 0, true);
-
-    // Add a step limiter to the gold block
-    G4double maxStepGold = 0.00001 * mm; // Set a maximum step size for the gold block
-    logicGoldBlock->SetUserLimits(new G4UserLimits(maxStepGold));
+    // Place the gold block (coating), its reflecting surface at y = 0
+    G4Box* solidGoldBlock = new G4Box("solidGoldBlock", fGoldBlockWidth / 2, fCoatingThickness / 2, fGoldBlockHeight / 2);
+    logicGoldBlock = new G4LogicalVolume(solidGoldBlock, coating, "logicGoldBlock");
+    new G4PVPlacement(0, G4ThreeVector(0., -fCoatingThickness / 2, 0.), logicGoldBlock, "physGoldBlock", logicWorld, false, 0, false);
+
+    if (fUniformStepLimit) {
+        // Reference setup: the fine step limit over the whole coating
+        if (fSkinMaxStep > 0.) {
+            logicGoldBlock->SetUserLimits(new G4UserLimits(fSkinMaxStep));
+        }
+    } else {
+        // Fine steps only in a thin skin below the grazing-incidence surface
+        G4double skinThickness = std::min(fSkinThickness, fCoatingThickness);
+        G4Box* solidGoldSkin = new G4Box("solidGoldSkin", fGoldBlockWidth / 2, skinThickness / 2, fGoldBlockHeight / 2);
+        logicGoldSkin = new G4LogicalVolume(solidGoldSkin, coating, "logicGoldSkin");
+        new G4PVPlacement(0, G4ThreeVector(0., (fCoatingThickness - skinThickness) / 2, 0.), logicGoldSkin, "physGoldSkin", logicGoldBlock, false, 0, false);
+        if (fSkinMaxStep > 0.) {
+            logicGoldSkin->SetUserLimits(new G4UserLimits(fSkinMaxStep));
+        }
+
+        if (fBulkMaxStep > 0.) {
+            logicGoldBlock->SetUserLimits(new G4UserLimits(fBulkMaxStep));
+        }
+    }
+
+    // Optional substrate below the coating (e.g. nickel as in the SRIM Gold+Nickel target)
+    if (fSubstrateThickness > 0.) {
+        G4Material* substrate = nist->FindOrBuildMaterial(fSubstrateMaterial);
+        G4Box* solidSubstrate = new G4Box("solidSubstrate", fGoldBlockWidth / 2, fSubstrateThickness / 2, fGoldBlockHeight / 2);
+        logicSubstrate = new G4LogicalVolume(solidSubstrate, substrate, "logicSubstrate");
+        new G4PVPlacement(0, G4ThreeVector(0., -fCoatingThickness - fSubstrateThickness / 2, 0.), logicSubstrate, "physSubstrate", logicWorld, false, 0, false);
+
+        if (fBulkMaxStep > 0.) {
+            logicSubstrate->SetUserLimits(new G4UserLimits(fBulkMaxStep));
+        }
+    }
 
     // // Load the GDML file
     // G4GDMLParser parser;
@@ -75,13 +142,211 @@ G4VPhysicalVolume* MyDetectorConstruction::Construct() {
     G4RotationMatrix* rotation = new G4RotationMatrix();
     rotation->rotateY(90.0 * deg); // Rotate the detector 90 degrees around the y-axis
 
-    G4Tubs* siliconDetector = new G4Tubs("siliconDetector", 0, detectorRadius, detectorThickness / 2, 0, 2 * M_PI);
+    G4Tubs* siliconDetector = new G4Tubs("siliconDetector", 0, fDetectorRadius, fDetectorThickness / 2, 0, 2 * M_PI);
     logicDetector = new G4LogicalVolume(siliconDetector, silicon, "logicDetector");
-    new G4PVPlacement(rotation, G4ThreeVector(-detectorXPosition, 0., 0.), logicDetector, "physDetector", logicWorld, false, 0, true);
+    new G4PVPlacement(rotation, G4ThreeVector(-fDetectorXPosition, 0., 0.), logicDetector, "physDetector", logicWorld, false, 0, false);
+
+    fConstructTime = GetSecondsSinceConstruct();
+    fGeometryRebuilt = (++fConstructCount > 1);
 
     return physWorld;
 }
 
+G4bool MyDetectorConstruction::GeometryWasRebuilt()
+{
+    G4bool rebuilt = fGeometryRebuilt;
+    fGeometryRebuilt = false;
+    return rebuilt;
+}
+
+G4double MyDetectorConstruction::GetSecondsSinceConstruct() const
+{
+    return std::chrono::duration<G4double>(std::chrono::steady_clock::now() - fConstructStart).count();
+}
+
+G4bool MyDetectorConstruction::IsReflectorVolume(const G4LogicalVolume* logicVolume) const
+{
+    return logicVolume && (logicVolume == logicGoldBlock || logicVolume == logicGoldSkin || logicVolume == logicSubstrate);
+}
+
+G4double MyDetectorConstruction::GetDepthBelowSurface(const G4VTouchable* touchable, const G4ThreeVector& globalPoint) const
+{
+    // The layers are slabs with their outer face towards +y in the local
+    // frame, and the skin shares its outer face with the coating. Curved
+    // shells will need their own case here
+    const G4LogicalVolume* logicVolume = touchable->GetVolume()->GetLogicalVolume();
+    G4ThreeVector localPoint = touchable->GetHistory()->GetTopTransform().TransformPoint(globalPoint);
+    G4double depth = static_cast<const G4Box*>(logicVolume->GetSolid())->GetYHalfLength() - localPoint.y();
+
+    // The substrate starts below the whole coating
+    if (logicVolume == logicSubstrate) {
+        depth += 2. * static_cast<const G4Box*>(logicGoldBlock->GetSolid())->GetYHalfLength();
+    }
+    return depth;
+}
+
+void MyDetectorConstruction::SetCoatingMaterial(const G4String& name)
+{
+    fCoatingMaterial = name;
+    G4RunManager::GetRunManager()->ReinitializeGeometry();
+}
+
+void MyDetectorConstruction::SetSubstrateMaterial(const G4String& name)
+{
+    fSubstrateMaterial = name;
+    G4RunManager::GetRunManager()->ReinitializeGeometry();
+}
+
+void MyDetectorConstruction::SetCoatingThickness(G4double value)
+{
+    if (value <= 0.) {
+        G4cerr << "Error: /thesis/foil/coatingThickness must be positive" << G4endl;
+        return;
+    }
+    fCoatingThickness = value;
+    G4RunManager::GetRunManager()->ReinitializeGeometry();
+}
+
+void MyDetectorConstruction::SetSkinThickness(G4double value)
+{
+    if (value <= 0.) {
+        G4cerr << "Error: /thesis/foil/skinThickness must be positive" << G4endl;
+        return;
+    }
+    fSkinThickness = value;
+    G4RunManager::GetRunManager()->ReinitializeGeometry();
+}
+
+void MyDetectorConstruction::SetSkinMaxStep(G4double value)
+{
+    if (value < 0.) {
+        G4cerr << "Error: /thesis/foil/skinMaxStep must be zero or positive" << G4endl;
+        return;
+    }
+    fSkinMaxStep = value;
+    G4RunManager::GetRunManager()->ReinitializeGeometry();
+}
+
+void MyDetectorConstruction::SetBulkMaxStep(G4double value)
+{
+    if (value < 0.) {
+        G4cerr << "Error: /thesis/foil/bulkMaxStep must be zero or positive" << G4endl;
+        return;
+    }
+    fBulkMaxStep = value;
+    G4RunManager::GetRunManager()->ReinitializeGeometry();
+}
+
+void MyDetectorConstruction::SetSubstrateThickness(G4double value)
+{
+    if (value < 0.) {
+        G4cerr << "Error: /thesis/foil/substrateThickness must be zero or positive" << G4endl;
+        return;
+    }
+    fSubstrateThickness = value;
+    G4RunManager::GetRunManager()->ReinitializeGeometry();
+}
+
+void MyDetectorConstruction::SetUniformStepLimit(G4bool value)
+{
+    fUniformStepLimit = value;
+    G4RunManager::GetRunManager()->ReinitializeGeometry();
+}
+
+void MyDetectorConstruction::SetGoldBlockWidth(G4double value)
+{
+    if (value <= 0.) {
+        G4cerr << "Error: /thesis/geometry/goldBlockWidth must be positive" << G4endl;
+        return;
+    }
+    fGoldBlockWidth = value;
+    G4RunManager::GetRunManager()->ReinitializeGeometry();
+}
+
+void MyDetectorConstruction::SetGoldBlockHeight(G4double value)
+{
+    if (value <= 0.) {
+        G4cerr << "Error: /thesis/geometry/goldBlockHeight must be positive" << G4endl;
+        return;
+    }
+    fGoldBlockHeight = value;
+    G4RunManager::GetRunManager()->ReinitializeGeometry();
+}
+
+void MyDetectorConstruction::SetDetectorRadius(G4double value)
+{
+    if (value <= 0.) {
+        G4cerr << "Error: /thesis/geometry/detectorRadius must be positive" << G4endl;
+        return;
+    }
+    fDetectorRadius = value;
+    G4RunManager::GetRunManager()->ReinitializeGeometry();
+}
+
+void MyDetectorConstruction::SetDetectorThickness(G4double value)
+{
+    if (value <= 0.) {
+        G4cerr << "Error: /thesis/geometry/detectorThickness must be positive" << G4endl;
+        return;
+    }
+    fDetectorThickness = value;
+    G4RunManager::GetRunManager()->ReinitializeGeometry();
+}
+
+void MyDetectorConstruction::SetDetectorXPosition(G4double value)
+{
+    fDetectorXPosition = value;
+    G4RunManager::GetRunManager()->ReinitializeGeometry();
+}
+
+void MyDetectorConstruction::DefineCommands()
+{
+    fMessenger = new G4GenericMessenger(this, "/thesis/foil/", "Reflecting element (coating, skin and substrate)");
+
+    fMessenger->DeclareMethod("coatingMaterial", &MyDetectorConstruction::SetCoatingMaterial,
+        "NIST material of the coating (default G4_Au)");
+
+    fMessenger->DeclareMethodWithUnit("coatingThickness", "um", &MyDetectorConstruction::SetCoatingThickness,
+        "Thickness of the coating");
+
+    fMessenger->DeclareMethodWithUnit("skinThickness", "nm", &MyDetectorConstruction::SetSkinThickness,
+        "Thickness of the fine-stepped surface skin");
+
+    fMessenger->DeclareMethodWithUnit("skinMaxStep", "nm", &MyDetectorConstruction::SetSkinMaxStep,
+        "Maximum step length in the surface skin (0 = no limit)");
+
+    fMessenger->DeclareMethodWithUnit("bulkMaxStep", "nm", &MyDetectorConstruction::SetBulkMaxStep,
+        "Maximum step length in the coating bulk and substrate (0 = no limit)");
+
+    fMessenger->DeclareMethod("substrateMaterial", &MyDetectorConstruction::SetSubstrateMaterial,
+        "NIST material of the substrate (default G4_Ni)");
+
+    fMessenger->DeclareMethodWithUnit("substrateThickness", "um", &MyDetectorConstruction::SetSubstrateThickness,
+        "Thickness of the substrate below the coating (0 = no substrate)");
+
+    fMessenger->DeclareMethod("uniformStepLimit", &MyDetectorConstruction::SetUniformStepLimit,
+        "Apply the skin step limit to the whole coating (reference setup)");
+
+    // Only the geometry is rebuilt on the next run; physics tables and
+    // worker threads are kept
+    fGeometryMessenger = new G4GenericMessenger(this, "/thesis/geometry/", "Gold block and detector placement");
+
+    fGeometryMessenger->DeclareMethodWithUnit("goldBlockWidth", "m", &MyDetectorConstruction::SetGoldBlockWidth,
+        "Width of the gold block along x");
+
+    fGeometryMessenger->DeclareMethodWithUnit("goldBlockHeight", "m", &MyDetectorConstruction::SetGoldBlockHeight,
+        "Height of the gold block along z");
+
+    fGeometryMessenger->DeclareMethodWithUnit("detectorRadius", "m", &MyDetectorConstruction::SetDetectorRadius,
+        "Radius of the silicon detector");
+
+    fGeometryMessenger->DeclareMethodWithUnit("detectorThickness", "m", &MyDetectorConstruction::SetDetectorThickness,
+        "Thickness of the silicon detector");
+
+    fGeometryMessenger->DeclareMethodWithUnit("detectorXPosition", "m", &MyDetectorConstruction::SetDetectorXPosition,
+        "Distance of the detector from the foil along the -x axis");
+}
+
 // const double FL = 0.8 * m; // Focal length
 // const double Lparabolic = 0.1 * m;
 // const double Lhyperbolic = 0.1 * m;
@@ -303,7 +568,13 @@ G4VPhysicalVolume* MyDetectorConstruction::Construct() {
 
 void MyDetectorConstruction::ConstructSDandField()
 {
-    MySensitiveDetector *sensDet = new MySensitiveDetector("SensitiveDetector");
+    // Reuse the detector when the geometry is rebuilt, so the hits file is kept
+    G4SDManager* sdManager = G4SDManager::GetSDMpointer();
+    G4VSensitiveDetector *sensDet = sdManager->FindSensitiveDetector("SensitiveDetector", false);
+    if (!sensDet) {
+        sensDet = new MySensitiveDetector("SensitiveDetector");
+        sdManager->AddNewDetector(sensDet);
+    }
 
     logicDetector->SetSensitiveDetector(sensDet);
 }
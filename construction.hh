@@ -10,6 +10,9 @@
 #include "G4LogicalVolume.hh"
 #include "G4GenericMessenger.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4VTouchable.hh"
+
+#include <chrono>
 
 #include "detector.hh"
 
@@ -24,9 +27,67 @@ public:
 
 	virtual G4VPhysicalVolume* Construct();
 
+	// True for the skin, bulk and substrate volumes of the reflecting element
+	G4bool IsReflectorVolume(const G4LogicalVolume* logicVolume) const;
+
+	// Depth of a point below the outer face of the coating, for a point in
+	// the reflector volume of the given touchable
+	G4double GetDepthBelowSurface(const G4VTouchable* touchable, const G4ThreeVector& globalPoint) const;
+
+	// True once after each rebuild of the geometry between runs
+	G4bool GeometryWasRebuilt();
+
+	// Duration of the last Construct() and wall time since it started, in seconds
+	G4double GetConstructTime() const { return fConstructTime; }
+	G4double GetSecondsSinceConstruct() const;
+
 private:
 	G4LogicalVolume *logicDetector;
+	G4LogicalVolume *logicGoldBlock;
+	G4LogicalVolume *logicGoldSkin;
+	G4LogicalVolume *logicSubstrate;
 	virtual void ConstructSDandField();
 
+	void SetCoatingMaterial(const G4String&);
+	void SetSubstrateMaterial(const G4String&);
+	void SetCoatingThickness(G4double);
+	void SetSkinThickness(G4double);
+	void SetSkinMaxStep(G4double);
+	void SetBulkMaxStep(G4double);
+	void SetSubstrateThickness(G4double);
+	void SetUniformStepLimit(G4bool);
+	void SetGoldBlockWidth(G4double);
+	void SetGoldBlockHeight(G4double);
+	void SetDetectorRadius(G4double);
+	void SetDetectorThickness(G4double);
+	void SetDetectorXPosition(G4double);
+	void DefineCommands();
+
+	G4GenericMessenger *fMessenger;
+	G4GenericMessenger *fGeometryMessenger;
+
+	// Reflecting element: coating (fine-stepped skin + bulk) on an optional substrate
+	G4String fCoatingMaterial;
+	G4String fSubstrateMaterial;
+	G4double fCoatingThickness;
+	G4double fSkinThickness;
+	G4double fSkinMaxStep;
+	G4double fBulkMaxStep;
+	G4double fSubstrateThickness;
+	G4bool fUniformStepLimit;
+
+	// Gold block and detector placement
+	G4double fGoldBlockWidth;
+	G4double fGoldBlockHeight;
+	G4double fDetectorThickness;
+	G4double fDetectorRadius;
+	G4double fDetectorXPosition;
+
+	// Geometry re-initialization timing
+	std::chrono::steady_clock::time_point fConstructStart;
+	G4double fConstructTime;
+	G4int fConstructCount;
+	G4bool fGeometryRebuilt;
+
 };
 #endif // !CONSTRUCTION_HH
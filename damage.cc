@@ -0,0 +1,138 @@
+#include "damage.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+MyDepthProfile::MyDepthProfile(const G4String& name)
+    : G4VAccumulable(name),
+      fMaxDepth(1. * um),
+      fBinWidth(1. * nm),
+      fEdep(1000, 0.),
+      fNiel(1000, 0.),
+      fEdepBeyond(0.),
+      fNielBeyond(0.)
+{}
+
+MyDepthProfile::~MyDepthProfile()
+{}
+
+void MyDepthProfile::Configure(G4int nBins, G4double maxDepth)
+{
+    nBins = std::max(nBins, 1);
+    fMaxDepth = maxDepth;
+    fBinWidth = maxDepth / nBins;
+    fEdep.assign(nBins, 0.);
+    fNiel.assign(nBins, 0.);
+    fEdepBeyond = 0.;
+    fNielBeyond = 0.;
+}
+
+void MyDepthProfile::Fill(G4double depth1, G4double depth2, G4double edep, G4double niel)
+{
+    if (edep <= 0. && niel <= 0.) {
+        return;
+    }
+
+    if (depth1 > depth2) {
+        std::swap(depth1, depth2);
+    }
+    depth1 = std::max(depth1, 0.);
+    depth2 = std::max(depth2, 0.);
+
+    // Bin nBins collects everything beyond the mesh
+    G4int nBins = G4int(fEdep.size());
+    G4int first = G4int(std::min(depth1 / fBinWidth, G4double(nBins)));
+    G4int last = G4int(std::min(depth2 / fBinWidth, G4double(nBins)));
+
+    G4double length = depth2 - depth1;
+    if (first == last || length <= 0.) {
+        AddToBin(first, edep, niel);
+        return;
+    }
+
+    for (G4int bin = first; bin <= last; ++bin) {
+        G4double low = std::max(depth1, bin * fBinWidth);
+        G4double high = bin < nBins ? std::min(depth2, (bin + 1) * fBinWidth) : depth2;
+        G4double fraction = (high - low) / length;
+        if (fraction > 0.) {
+            AddToBin(bin, edep * fraction, niel * fraction);
+        }
+    }
+}
+
+void MyDepthProfile::AddToBin(G4int bin, G4double edep, G4double niel)
+{
+    if (bin < G4int(fEdep.size())) {
+        fEdep[bin] += edep;
+        fNiel[bin] += niel;
+    } else {
+        fEdepBeyond += edep;
+        fNielBeyond += niel;
+    }
+}
+
+void MyDepthProfile::Merge(const G4VAccumulable& other)
+{
+    const MyDepthProfile& otherProfile = static_cast<const MyDepthProfile&>(other);
+
+    std::size_t nBins = std::min(fEdep.size(), otherProfile.fEdep.size());
+    for (std::size_t i = 0; i < nBins; ++i) {
+        fEdep[i] += otherProfile.fEdep[i];
+        fNiel[i] += otherProfile.fNiel[i];
+    }
+    fEdepBeyond += otherProfile.fEdepBeyond;
+    fNielBeyond += otherProfile.fNielBeyond;
+}
+
+void MyDepthProfile::Reset()
+{
+    std::fill(fEdep.begin(), fEdep.end(), 0.);
+    std::fill(fNiel.begin(), fNiel.end(), 0.);
+    fEdepBeyond = 0.;
+    fNielBeyond = 0.;
+}
+
+#if G4VERSION_NUMBER >= 1130
+void MyDepthProfile::Print(G4PrintOptions) const
+{
+    G4double edep = fEdepBeyond;
+    G4double niel = fNielBeyond;
+    for (std::size_t i = 0; i < fEdep.size(); ++i) {
+        edep += fEdep[i];
+        niel += fNiel[i];
+    }
+    G4cout << GetName() << ": " << fEdep.size() << " bins to " << fMaxDepth / nm << " nm, Edep "
+           << edep / keV << " keV, NIEL " << niel / keV << " keV" << G4endl;
+}
+#endif
+
+void MyDepthProfile::Write(const G4String& fileName, G4int nIons, G4double displacementEnergy) const
+{
+    std::ofstream outFile(fileName, std::ios::trunc);
+
+    G4double binWidth = fBinWidth / angstrom;
+    G4double perIon = nIons > 0 ? 1. / nIons : 0.;
+    G4double norm = perIon / binWidth;
+
+    outFile << "# Depth profile in the reflecting element, comparable with SRIM IONIZ.txt / VACANCY.txt\n";
+    outFile << "# Ions: " << nIons << ", bin width: " << binWidth << " A"
+            << ", displacement energy: " << displacementEnergy / eV << " eV\n";
+    outFile << "# Beyond " << fMaxDepth / angstrom << " A (not binned): Edep " << fEdepBeyond / eV * perIon
+            << " eV/Ion, NIEL " << fNielBeyond / eV * perIon << " eV/Ion\n";
+    // NRT applies per recoil and gives no displacement below Ed; on the binned
+    // NIEL of all recoils the linear form only bounds the displacements
+    outFile << "# DispMax: NRT upper bound 0.8 * NIEL / (2 * Ed) on the binned NIEL,"
+            << " ignores the sub-threshold cutoff per recoil\n";
+    outFile << "# Depth(A)  Edep(eV/(A-Ion))  Ioniz(eV/(A-Ion))  NIEL(eV/(A-Ion))  DispMax(1/(A-Ion))\n";
+
+    outFile << std::scientific << std::setprecision(5);
+    for (std::size_t i = 0; i < fEdep.size(); ++i) {
+        G4double edep = fEdep[i] / eV * norm;
+        G4double niel = fNiel[i] / eV * norm;
+        G4double displacements = 0.8 * niel / (2. * displacementEnergy / eV);
+        outFile << (i + 0.5) * binWidth << "  " << edep << "  " << edep - niel << "  "
+                << niel << "  " << displacements << "\n";
+    }
+}
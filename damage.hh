@@ -0,0 +1,48 @@
+#ifndef DAMAGE_HH
+#define DAMAGE_HH
+
+#include "G4VAccumulable.hh"
+#include "G4Version.hh"
+#include "globals.hh"
+
+#include <vector>
+
+// Energy deposition and non-ionising energy loss (NIEL) against depth below
+// the reflecting surface, on a fixed mesh. Each thread fills its own copy;
+// the copies are merged by G4AccumulableManager at the end of the run, so
+// the cost does not grow with the number of tracks.
+class MyDepthProfile : public G4VAccumulable
+{
+public:
+    MyDepthProfile(const G4String& name);
+    ~MyDepthProfile();
+
+    // Resizes and clears the mesh, call before the run starts
+    void Configure(G4int nBins, G4double maxDepth);
+
+    // Spreads a step's deposits uniformly over the depth interval it covers
+    void Fill(G4double depth1, G4double depth2, G4double edep, G4double niel);
+
+    virtual void Merge(const G4VAccumulable& other);
+    virtual void Reset();
+#if G4VERSION_NUMBER >= 1130
+    virtual void Print(G4PrintOptions options = G4PrintOptions()) const;
+#endif
+
+    // Writes the profile per incident ion, with depth in Angstrom as in the
+    // SRIM IONIZ.txt / VACANCY.txt outputs. Displacements are an upper bound
+    // from the linear NRT formula with the given displacement energy.
+    void Write(const G4String& fileName, G4int nIons, G4double displacementEnergy) const;
+
+private:
+    void AddToBin(G4int bin, G4double edep, G4double niel);
+
+    G4double fMaxDepth;
+    G4double fBinWidth;
+    std::vector<G4double> fEdep;
+    std::vector<G4double> fNiel;
+    G4double fEdepBeyond;
+    G4double fNielBeyond;
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include "detector.hh"
 #include <fstream> // Include for file handling
+#include "telemetry.hh"
 
 MySensitiveDetector::MySensitiveDetector(G4String name) : G4VSensitiveDetector(name)
 {
@@ -18,6 +19,7 @@ G4bool MySensitiveDetector::ProcessHits(G4Step *aStep, G4TouchableHistory *ROhis
 
     // Stop the track after it hits the detector
     track->SetTrackStatus(fStopAndKill);
+    MyTelemetry::Instance()->AddHit();
 
     // Get the particle type
     G4String particleName = track->GetDefinition()->GetParticleName();
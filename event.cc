@@ -0,0 +1,26 @@
+#include "event.hh"
+#include "telemetry.hh"
+
+MyEventAction::MyEventAction(MyRunAction* runAction)
+    : G4UserEventAction(),
+      fRunAction(runAction),
+      fSteps(0),
+      fReflectorSteps(0)
+{}
+
+MyEventAction::~MyEventAction()
+{}
+
+void MyEventAction::BeginOfEventAction(const G4Event*)
+{
+    fSteps = 0;
+    fReflectorSteps = 0;
+}
+
+void MyEventAction::EndOfEventAction(const G4Event*)
+{
+    // Steps are counted per thread and handed over once per event, so the
+    // telemetry and the run summary see the same count
+    fRunAction->AddEventSteps(fSteps, fReflectorSteps);
+    MyTelemetry::Instance()->AddEvent(fSteps);
+}
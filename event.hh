@@ -0,0 +1,31 @@
+#ifndef EVENT_HH
+#define EVENT_HH
+
+#include "G4UserEventAction.hh"
+#include "G4Event.hh"
+
+#include "run.hh"
+
+class MyEventAction : public G4UserEventAction
+{
+public:
+    MyEventAction(MyRunAction*);
+    ~MyEventAction();
+
+    virtual void BeginOfEventAction(const G4Event*);
+    virtual void EndOfEventAction(const G4Event*);
+
+    // Step counters of the current event, filled by the stepping action
+    void AddStep(G4bool inReflector)
+    {
+        fSteps++;
+        if (inReflector) fReflectorSteps++;
+    }
+
+private:
+    MyRunAction* fRunAction;
+    G4long fSteps;
+    G4long fReflectorSteps;
+};
+
+#endif
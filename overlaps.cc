@@ -0,0 +1,277 @@
+#include "overlaps.hh"
+#include "G4TransportationManager.hh"
+#include "G4Navigator.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VSolid.hh"
+#include "G4Material.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Timer.hh"
+#include "G4StateManager.hh"
+#include "G4VExceptionHandler.hh"
+#include "G4Threading.hh"
+#include "G4ios.hh"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <set>
+#include <sstream>
+
+// Collects the overlap warnings of one CheckOverlaps call, so each failing
+// volume is reported once in the summary instead of by G4Exception. Installed
+// on the state manager of the thread running the check
+class MyOverlapCollector : public G4VExceptionHandler
+{
+public:
+    G4bool Notify(const char* originOfException, const char* exceptionCode,
+        G4ExceptionSeverity severity, const char* description) override
+    {
+        if (severity == JustWarning && G4String(exceptionCode) == "GeomVol1002") {
+            fMessages << description << "\n";
+            return false;
+        }
+
+        G4cerr << "*** G4Exception " << exceptionCode << " from " << originOfException << "\n"
+               << description << G4endl;
+        return severity == FatalException || severity == FatalErrorInArgument;
+    }
+
+    std::ostringstream fMessages;
+};
+
+MyOverlapValidator* MyOverlapValidator::Instance()
+{
+    // Never deleted, like MyTelemetry
+    static MyOverlapValidator* instance = new MyOverlapValidator();
+    return instance;
+}
+
+MyOverlapValidator::MyOverlapValidator()
+    : fMessenger(nullptr),
+      fCacheFile("overlap_cache.txt"),
+      fResolution(1000),
+      fTolerance(0.),
+      fThreads(0),
+      fLastPassed(false)
+{
+    fMessenger = new G4GenericMessenger(this, "/thesis/overlaps/", "Cached geometry overlap validation");
+
+    fMessenger->DeclareMethod("check", &MyOverlapValidator::Check,
+        "Check for overlaps unless this geometry is already in the cache");
+
+    fMessenger->DeclareMethod("force", &MyOverlapValidator::ForceCheck,
+        "Run the full recursive overlap check, ignoring the cache");
+
+    fMessenger->DeclareProperty("resolution", fResolution,
+        "Number of surface points per volume");
+
+    fMessenger->DeclarePropertyWithUnit("tolerance", "um", fTolerance,
+        "Overlaps below this distance are ignored");
+
+    fMessenger->DeclareProperty("threads", fThreads,
+        "Threads for the forced check (0 = all cores)");
+
+    fMessenger->DeclareProperty("cacheFile", fCacheFile,
+        "File the pass/fail records are stored in");
+}
+
+MyOverlapValidator::~MyOverlapValidator()
+{
+    delete fMessenger;
+}
+
+G4bool MyOverlapValidator::Validate(G4bool force)
+{
+    G4VPhysicalVolume* world = GetWorldVolume();
+    if (!world) {
+        G4cerr << "Error: no world volume to check for overlaps" << G4endl;
+        return false;
+    }
+
+    G4String hash = HashGeometry(world);
+    if (!force && hash == fLastHash) {
+        return fLastPassed;
+    }
+
+    G4bool passed = false;
+    if (!force && FindCachedResult(hash, passed)) {
+        G4cout << "Overlap check skipped: geometry " << hash << " already "
+               << (passed ? "passed" : "FAILED") << " (" << fCacheFile << ")" << G4endl;
+        fLastHash = hash;
+        fLastPassed = passed;
+        return passed;
+    }
+
+    // Every placement once, depth first, like /geometry/test/recursive_depth -1
+    std::vector<G4VPhysicalVolume*> volumes;
+    std::set<const G4LogicalVolume*> visited;
+    std::vector<const G4LogicalVolume*> pending = { world->GetLogicalVolume() };
+    while (!pending.empty()) {
+        const G4LogicalVolume* mother = pending.back();
+        pending.pop_back();
+        if (!visited.insert(mother).second) {
+            continue;
+        }
+        for (std::size_t i = 0; i < mother->GetNoDaughters(); ++i) {
+            G4VPhysicalVolume* daughter = mother->GetDaughter(i);
+            volumes.push_back(daughter);
+            pending.push_back(daughter->GetLogicalVolume());
+        }
+    }
+
+    G4Timer timer;
+    timer.Start();
+    passed = RunChecks(volumes, force);
+    timer.Stop();
+
+    StoreResult(hash, passed);
+    fLastHash = hash;
+    fLastPassed = passed;
+
+    G4cout << "Overlap check of geometry " << hash << ": " << (passed ? "passed" : "FAILED")
+           << " (" << volumes.size() << " volumes, " << timer.GetRealElapsed() << " s)" << G4endl;
+    return passed;
+}
+
+G4VPhysicalVolume* MyOverlapValidator::GetWorldVolume() const
+{
+    G4Navigator* navigator = G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking();
+    if (navigator && navigator->GetWorldVolume()) {
+        return navigator->GetWorldVolume();
+    }
+    return G4PhysicalVolumeStore::GetInstance()->GetVolume("physWorld", false);
+}
+
+G4String MyOverlapValidator::HashGeometry(const G4VPhysicalVolume* world) const
+{
+    std::ostringstream os;
+    os << std::setprecision(17);
+    os << "resolution " << fResolution << " tolerance " << fTolerance << "\n";
+    Describe(world, os);
+
+    // 64-bit FNV-1a over the geometry description
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : os.str()) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+
+    std::ostringstream hex;
+    hex << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return hex.str();
+}
+
+void MyOverlapValidator::Describe(const G4VPhysicalVolume* volume, std::ostream& os) const
+{
+    const G4LogicalVolume* logicVolume = volume->GetLogicalVolume();
+    const G4ThreeVector& translation = volume->GetTranslation();
+
+    os << volume->GetName() << " " << volume->GetCopyNo() << " "
+       << translation.x() << " " << translation.y() << " " << translation.z();
+
+    const G4RotationMatrix* rotation = volume->GetRotation();
+    if (rotation) {
+        os << " " << rotation->xx() << " " << rotation->xy() << " " << rotation->xz()
+           << " " << rotation->yx() << " " << rotation->yy() << " " << rotation->yz()
+           << " " << rotation->zx() << " " << rotation->zy() << " " << rotation->zz();
+    }
+
+    os << " " << logicVolume->GetName() << " " << logicVolume->GetMaterial()->GetName() << "\n";
+    logicVolume->GetSolid()->StreamInfo(os);
+
+    for (std::size_t i = 0; i < logicVolume->GetNoDaughters(); ++i) {
+        Describe(logicVolume->GetDaughter(i), os);
+    }
+}
+
+G4bool MyOverlapValidator::RunChecks(const std::vector<G4VPhysicalVolume*>& volumes, G4bool parallel) const
+{
+    std::vector<char> overlaps(volumes.size(), 0);
+    std::vector<std::string> reports(volumes.size());
+
+    // G4Thread is a placeholder without G4MULTITHREADED, the check then
+    // runs serially
+    G4bool threaded = false;
+#ifdef G4MULTITHREADED
+    G4int nThreads = fThreads > 0 ? fThreads : G4Threading::G4GetNumberOfCores();
+    nThreads = std::min(nThreads, G4int(volumes.size()));
+    if (parallel && nThreads > 1) {
+        // The first GetPointOnSurface call of a solid fills its surface cache
+        std::set<G4VSolid*> solids;
+        for (G4VPhysicalVolume* volume : volumes) {
+            G4VSolid* solid = volume->GetLogicalVolume()->GetSolid();
+            if (solids.insert(solid).second) {
+                solid->GetPointOnSurface();
+            }
+        }
+
+        std::atomic<std::size_t> next(0);
+        auto worker = [&]() {
+            for (std::size_t i = next++; i < volumes.size(); i = next++) {
+                overlaps[i] = CheckVolume(volumes[i], reports[i]);
+            }
+        };
+
+        std::vector<G4Thread> threads;
+        for (G4int i = 0; i < nThreads; ++i) {
+            threads.emplace_back(worker);
+        }
+        for (G4Thread& thread : threads) {
+            thread.join();
+        }
+        threaded = true;
+    }
+#endif
+
+    if (!threaded) {
+        for (std::size_t i = 0; i < volumes.size(); ++i) {
+            overlaps[i] = CheckVolume(volumes[i], reports[i]);
+        }
+    }
+
+    G4int nFailed = 0;
+    for (std::size_t i = 0; i < volumes.size(); ++i) {
+        if (overlaps[i]) {
+            ++nFailed;
+            G4cout << "Overlap in " << volumes[i]->GetName() << ":\n" << reports[i] << G4endl;
+        }
+    }
+    return nFailed == 0;
+}
+
+G4bool MyOverlapValidator::CheckVolume(G4VPhysicalVolume* volume, std::string& report) const
+{
+    G4StateManager* stateManager = G4StateManager::GetStateManager();
+    G4VExceptionHandler* previousHandler = stateManager->GetExceptionHandler();
+
+    MyOverlapCollector collector;
+    stateManager->SetExceptionHandler(&collector);
+    G4bool overlaps = volume->CheckOverlaps(fResolution, fTolerance, false, 1);
+    stateManager->SetExceptionHandler(previousHandler);
+
+    report = collector.fMessages.str();
+    return overlaps;
+}
+
+G4bool MyOverlapValidator::FindCachedResult(const G4String& hash, G4bool& passed) const
+{
+    // One "<hash> pass|fail" record per line, the last record wins
+    std::ifstream inFile(fCacheFile);
+    std::string recordHash, result;
+    G4bool found = false;
+    while (inFile >> recordHash >> result) {
+        if (recordHash == hash) {
+            passed = (result == "pass");
+            found = true;
+        }
+    }
+    return found;
+}
+
+void MyOverlapValidator::StoreResult(const G4String& hash, G4bool passed) const
+{
+    std::ofstream outFile(fCacheFile, std::ios::app);
+    outFile << hash << " " << (passed ? "pass" : "fail") << "\n";
+}
@@ -0,0 +1,52 @@
+#ifndef OVERLAPS_HH
+#define OVERLAPS_HH
+
+#include "globals.hh"
+#include "G4GenericMessenger.hh"
+#include "G4VPhysicalVolume.hh"
+
+#include <vector>
+
+// Overlap validation of the geometry, run once per geometry description.
+// The geometry tree is hashed and the pass/fail result is recorded in a
+// local cache file, so unchanged geometry is not re-checked on later
+// launches. The last result is kept in memory, so calling it at every run
+// start is cheap. The cached check runs serially on the calling thread.
+// Forced mode ignores the cache and spreads the volumes over threads; the
+// lazy surface caches of the solids (polycone, boolean) are filled serially
+// first, so the threads only read them. Configured through /thesis/overlaps/.
+class MyOverlapValidator
+{
+public:
+    static MyOverlapValidator* Instance();
+
+    // Returns true if the current geometry has no overlaps
+    G4bool Validate(G4bool force);
+
+private:
+    MyOverlapValidator();
+    ~MyOverlapValidator();
+
+    void Check() { Validate(false); }
+    void ForceCheck() { Validate(true); }
+
+    G4VPhysicalVolume* GetWorldVolume() const;
+    G4String HashGeometry(const G4VPhysicalVolume* world) const;
+    void Describe(const G4VPhysicalVolume* volume, std::ostream& os) const;
+    G4bool RunChecks(const std::vector<G4VPhysicalVolume*>& volumes, G4bool parallel) const;
+    G4bool CheckVolume(G4VPhysicalVolume* volume, std::string& report) const;
+
+    G4bool FindCachedResult(const G4String& hash, G4bool& passed) const;
+    void StoreResult(const G4String& hash, G4bool passed) const;
+
+    G4GenericMessenger* fMessenger;
+    G4String fCacheFile;
+    G4int fResolution;
+    G4double fTolerance;
+    G4int fThreads;
+
+    G4String fLastHash;
+    G4bool fLastPassed;
+};
+
+#endif
@@ -14,6 +14,7 @@
 #include "G4hBremsstrahlung.hh"
 #include "G4hIonisation.hh"
 #include "G4hMultipleScattering.hh"
+#include "G4StepLimiterPhysics.hh"
 #include "G4Proton.hh"
 #include "G4ParticleDefinition.hh"
 #include "G4ParticleTable.hh"
@@ -22,6 +23,10 @@ MyPhysicsList::MyPhysicsList() {
     // Electromagnetic physics
     RegisterPhysics(new G4EmStandardPhysics_option3());
 
+    // Applies the G4UserLimits max steps of the reflector (and the world),
+    // without it they are ignored
+    RegisterPhysics(new G4StepLimiterPhysics());
+
     // Define the proton explicitly
     G4ParticleTable* particleTable = G4ParticleTable::GetParticleTable();
     G4ParticleDefinition* proton = particleTable->FindParticle("proton");
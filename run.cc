@@ -0,0 +1,283 @@
+#include "run.hh"
+#include "G4AccumulableManager.hh"
+#include "G4AnalysisManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "telemetry.hh"
+#include "overlaps.hh"
+#include "G4ios.hh"
+#include "G4Threading.hh"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <string>
+
+// Chi2/ndf between two unweighted histograms of different totals
+// (Chi2Test "UU"), computed on the bin contents
+static G4double ChiSquarePerNdf(const std::vector<G4double>& h1, const std::vector<G4double>& h2)
+{
+    G4double n1 = 0., n2 = 0.;
+    for (std::size_t i = 0; i < h1.size(); ++i) {
+        n1 += h1[i];
+        n2 += h2[i];
+    }
+    if (n1 <= 0. || n2 <= 0.) {
+        return -1.;
+    }
+
+    G4double chi2 = 0.;
+    G4int ndf = -1;
+    for (std::size_t i = 0; i < h1.size(); ++i) {
+        G4double sum = h1[i] + h2[i];
+        if (sum > 0.) {
+            G4double diff = n2 * h1[i] - n1 * h2[i];
+            chi2 += diff * diff / (n1 * n2 * sum);
+            ++ndf;
+        }
+    }
+    return ndf > 0 ? chi2 / ndf : 0.;
+}
+
+// Kolmogorov-Smirnov distance between the normalised cumulative distributions
+static G4double KolmogorovDistance(const std::vector<G4double>& h1, const std::vector<G4double>& h2)
+{
+    G4double n1 = 0., n2 = 0.;
+    for (std::size_t i = 0; i < h1.size(); ++i) {
+        n1 += h1[i];
+        n2 += h2[i];
+    }
+    if (n1 <= 0. || n2 <= 0.) {
+        return -1.;
+    }
+
+    G4double cdf1 = 0., cdf2 = 0., distance = 0.;
+    for (std::size_t i = 0; i < h1.size(); ++i) {
+        cdf1 += h1[i] / n1;
+        cdf2 += h2[i] / n2;
+        distance = std::max(distance, std::abs(cdf1 - cdf2));
+    }
+    return distance;
+}
+
+// Set by the master after a geometry rebuild, the first worker to start its
+// run records the time since Construct() and clears it
+static std::atomic<G4bool> awaitingFirstWorker(false);
+static std::atomic<G4double> firstWorkerReadyTime(-1.);
+
+// In-range bin contents of a histogram
+static std::vector<G4double> GetBinContents(const G4AnalysisManager* analysisManager, G4int id)
+{
+    auto h1 = analysisManager->GetH1(id);
+    std::vector<G4double> contents(h1->axis().bins());
+    for (std::size_t i = 0; i < contents.size(); ++i) {
+        contents[i] = h1->bin_Sw(G4int(i));
+    }
+    return contents;
+}
+
+MyRunAction::MyRunAction(MyDetectorConstruction* detectorConstruction)
+    : G4UserRunAction(),
+      fDetectorConstruction(detectorConstruction),
+      fKilledSecondaries(0),
+      fDeferredSecondaries(0),
+      fCulledSecondaries(0),
+      fCulledPrimaries(0),
+      fSteps(0),
+      fReflectorSteps(0),
+      fDepthProfile("depthProfile"),
+      fMessenger(nullptr),
+      fDamageBins(1000),
+      fDamageMaxDepth(1. * um),
+      fDisplacementEnergy(25. * eV),   // Au and Ni, as in the SRIM COLLISON_*.txt runs
+      fDamageFileName("damage_profile"),
+      fBenchMessenger(nullptr),
+      fStoreReference(false),
+      fReportReinit(false),
+      fReinitMasterTime(0.),
+      fReinitValidationTime(0.)
+{
+    // Create the telemetry (and its commands) on the master; IsMaster() is
+    // only set after construction
+    if (G4Threading::IsMasterThread()) {
+        MyTelemetry::Instance();
+    }
+
+    // Register the counters so they are merged from the worker threads
+    G4AccumulableManager* accumulableManager = G4AccumulableManager::Instance();
+    accumulableManager->RegisterAccumulable(fKilledSecondaries);
+    accumulableManager->RegisterAccumulable(fDeferredSecondaries);
+    accumulableManager->RegisterAccumulable(fCulledSecondaries);
+    accumulableManager->RegisterAccumulable(fCulledPrimaries);
+    accumulableManager->RegisterAccumulable(fSteps);
+    accumulableManager->RegisterAccumulable(fReflectorSteps);
+    accumulableManager->RegisterAccumulable(&fDepthProfile);
+
+    // Every thread has its own messenger, so all depth meshes match
+    fMessenger = new G4GenericMessenger(this, "/thesis/damage/", "Depth profile of deposits in the reflecting element");
+
+    fMessenger->DeclareProperty("bins", fDamageBins,
+        "Number of depth bins");
+
+    fMessenger->DeclarePropertyWithUnit("maxDepth", "um", fDamageMaxDepth,
+        "Depth covered by the mesh, deposits beyond are only summed");
+
+    fMessenger->DeclarePropertyWithUnit("displacementEnergy", "eV", fDisplacementEnergy,
+        "Displacement energy Ed for the NRT upper bound");
+
+    fMessenger->DeclareProperty("fileName", fDamageFileName,
+        "Output file name, the run number and .txt are appended");
+
+    // Scattering distributions of primaries leaving the reflecting element,
+    // used to compare stepping setups (see bench_stepping.mac)
+    G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+    analysisManager->SetDefaultFileType("csv");
+    analysisManager->SetFileName("scattering");
+    analysisManager->SetVerboseLevel(0);
+    analysisManager->CreateH1("exitAngle", "Exit angle above the surface (deg)", 180, 0., 90.);
+    analysisManager->CreateH1("exitEnergy", "Kinetic energy at exit / primary energy", 105, 0., 1.05);
+
+    fBenchMessenger = new G4GenericMessenger(this, "/thesis/bench/", "Comparison of scattering distributions between runs");
+
+    fBenchMessenger->DeclareMethod("setReference", &MyRunAction::UseNextRunAsReference,
+        "Keep the exit distributions of the next run as the reference");
+
+    fBenchMessenger->DeclareMethod("clearReference", &MyRunAction::ClearReference,
+        "Forget the reference distributions");
+}
+
+MyRunAction::~MyRunAction()
+{
+    delete fMessenger;
+    delete fBenchMessenger;
+}
+
+void MyRunAction::BeginOfRunAction(const G4Run* run)
+{
+    fDepthProfile.Configure(fDamageBins, fDamageMaxDepth);
+    G4AccumulableManager::Instance()->Reset();
+    G4AnalysisManager::Instance()->OpenFile();
+
+    if (IsMaster()) {
+        fReportReinit = fDetectorConstruction->GeometryWasRebuilt();
+        fReinitMasterTime = fDetectorConstruction->GetSecondsSinceConstruct();
+
+        // A new geometry is checked once; unchanged ones hit the cache
+        MyOverlapValidator::Instance()->Validate(false);
+        fReinitValidationTime = fDetectorConstruction->GetSecondsSinceConstruct() - fReinitMasterTime;
+
+        // Workers update their navigators and couples in their own run
+        // initialization, before their BeginOfRunAction
+        if (fReportReinit) {
+            firstWorkerReadyTime = -1.;
+            awaitingFirstWorker = G4Threading::IsMultithreadedApplication();
+        }
+
+        MyTelemetry::Instance()->StartRun(run->GetRunID(), run->GetNumberOfEventToBeProcessed());
+    } else if (awaitingFirstWorker.exchange(false)) {
+        firstWorkerReadyTime = fDetectorConstruction->GetSecondsSinceConstruct();
+    }
+
+    fTimer.Start();
+}
+
+void MyRunAction::AddReflectorExit(const G4ThreeVector& dir, G4double energyFraction)
+{
+    // Only primaries going back above the surface count as reflected
+    if (dir.y() <= 0.) {
+        return;
+    }
+
+    G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+    analysisManager->FillH1(0, std::asin(dir.y()) / deg);
+    analysisManager->FillH1(1, energyFraction);
+}
+
+void MyRunAction::ClearReference()
+{
+    fStoreReference = false;
+    fReferenceAngle.clear();
+    fReferenceEnergy.clear();
+}
+
+void MyRunAction::CompareWithReference()
+{
+    const G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+
+    if (fStoreReference) {
+        fReferenceAngle = GetBinContents(analysisManager, 0);
+        fReferenceEnergy = GetBinContents(analysisManager, 1);
+        fStoreReference = false;
+        G4cout << "Exit distributions stored as reference" << G4endl;
+        return;
+    }
+
+    if (fReferenceAngle.empty()) {
+        return;
+    }
+
+    std::vector<G4double> angle = GetBinContents(analysisManager, 0);
+    std::vector<G4double> energy = GetBinContents(analysisManager, 1);
+    G4cout << "Exit angle vs reference: chi2/ndf " << ChiSquarePerNdf(fReferenceAngle, angle)
+           << ", KS distance " << KolmogorovDistance(fReferenceAngle, angle) << G4endl;
+    G4cout << "Exit energy vs reference: chi2/ndf " << ChiSquarePerNdf(fReferenceEnergy, energy)
+           << ", KS distance " << KolmogorovDistance(fReferenceEnergy, energy) << G4endl;
+}
+
+void MyRunAction::PrintReinitializationTime() const
+{
+    // The overlap validation on the master is not part of the re-initialization
+    G4cout << "Geometry re-initialization: master-side " << fReinitMasterTime * 1000. << " ms"
+           << " (Construct " << fDetectorConstruction->GetConstructTime() * 1000. << " ms)";
+    if (firstWorkerReadyTime >= 0.) {
+        G4cout << ", first worker ready " << (firstWorkerReadyTime - fReinitValidationTime) * 1000. << " ms";
+    }
+    G4cout << G4endl;
+}
+
+void MyRunAction::EndOfRunAction(const G4Run* run)
+{
+    fTimer.Stop();
+    if (IsMaster()) {
+        MyTelemetry::Instance()->StopRun();
+    }
+    G4AccumulableManager::Instance()->Merge();
+
+    G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+    analysisManager->Write();
+
+    if (!IsMaster() || run->GetNumberOfEvent() == 0) {
+        analysisManager->CloseFile();
+        return;
+    }
+
+    G4int nEvents = run->GetNumberOfEvent();
+
+    G4cout << "\n--------------------- Track culling summary ---------------------" << G4endl;
+    G4cout << "Events processed: " << nEvents << G4endl;
+    G4cout << "Secondaries killed below threshold: " << fKilledSecondaries.GetValue() << G4endl;
+    G4cout << "Secondaries deferred to waiting stack: " << fDeferredSecondaries.GetValue() << G4endl;
+    G4cout << "Secondaries outside detector acceptance: " << fCulledSecondaries.GetValue() << G4endl;
+    G4cout << "Primaries outside detector acceptance: " << fCulledPrimaries.GetValue() << G4endl;
+    G4cout << "-----------------------------------------------------------------" << G4endl;
+
+    G4cout << "\n--------------------- Stepping summary --------------------------" << G4endl;
+    G4cout << "Wall time: " << fTimer.GetRealElapsed() << " s ("
+           << nEvents / std::max(fTimer.GetRealElapsed(), 1e-9) << " events/s)" << G4endl;
+    G4cout << "Steps per event: " << G4double(fSteps.GetValue()) / nEvents << G4endl;
+    G4cout << "Steps per event in reflector: " << G4double(fReflectorSteps.GetValue()) / nEvents << G4endl;
+    if (fReportReinit) {
+        PrintReinitializationTime();
+    }
+    G4cout << "Reflected primaries: " << analysisManager->GetH1(0)->entries()
+           << ", exit angle mean " << analysisManager->GetH1(0)->mean()
+           << " deg, rms " << analysisManager->GetH1(0)->rms() << " deg" << G4endl;
+    G4cout << "Exit energy fraction mean " << analysisManager->GetH1(1)->mean()
+           << ", rms " << analysisManager->GetH1(1)->rms() << G4endl;
+    CompareWithReference();
+    G4cout << "-----------------------------------------------------------------" << G4endl;
+
+    G4String damageFileName = fDamageFileName + "_run" + std::to_string(run->GetRunID()) + ".txt";
+    fDepthProfile.Write(damageFileName, nEvents, fDisplacementEnergy);
+    G4cout << "Depth profile written to " << damageFileName << G4endl;
+
+    analysisManager->CloseFile();
+}
@@ -0,0 +1,88 @@
+#ifndef RUN_HH
+#define RUN_HH
+
+#include "G4UserRunAction.hh"
+#include "G4Accumulable.hh"
+#include "G4Run.hh"
+#include "G4ThreeVector.hh"
+#include "G4Timer.hh"
+#include "G4GenericMessenger.hh"
+
+#include "damage.hh"
+
+#include "construction.hh"
+
+#include <vector>
+
+class MyRunAction : public G4UserRunAction
+{
+public:
+    MyRunAction(MyDetectorConstruction*);
+    ~MyRunAction();
+
+    virtual void BeginOfRunAction(const G4Run*);
+    virtual void EndOfRunAction(const G4Run*);
+
+    // Track culling counters, filled by the stacking and stepping actions
+    void AddKilledSecondary() { fKilledSecondaries += 1; }
+    void AddDeferredSecondary() { fDeferredSecondaries += 1; }
+    void AddCulledSecondary() { fCulledSecondaries += 1; }
+    void AddCulledPrimary() { fCulledPrimaries += 1; }
+
+    // Step counts of an event, filled by the event action
+    void AddEventSteps(G4long steps, G4long reflectorSteps)
+    {
+        fSteps += steps;
+        fReflectorSteps += reflectorSteps;
+    }
+
+    // Direction and energy of a primary leaving the reflecting element,
+    // the energy relative to the primary's initial energy
+    void AddReflectorExit(const G4ThreeVector& dir, G4double energyFraction);
+
+    // Deposits of a step in the reflecting element, depths below the surface
+    void AddDepthDeposit(G4double depth1, G4double depth2, G4double edep, G4double niel)
+    {
+        fDepthProfile.Fill(depth1, depth2, edep, niel);
+    }
+
+private:
+    MyDetectorConstruction* fDetectorConstruction;
+
+    void UseNextRunAsReference() { fStoreReference = true; }
+    void ClearReference();
+    void CompareWithReference();
+    void PrintReinitializationTime() const;
+
+    G4Accumulable<G4int> fKilledSecondaries;
+    G4Accumulable<G4int> fDeferredSecondaries;
+    G4Accumulable<G4int> fCulledSecondaries;
+    G4Accumulable<G4int> fCulledPrimaries;
+    G4Accumulable<G4long> fSteps;
+    G4Accumulable<G4long> fReflectorSteps;
+    MyDepthProfile fDepthProfile;
+
+    // Depth profile settings, set through /thesis/damage/
+    G4GenericMessenger* fMessenger;
+    G4int fDamageBins;
+    G4double fDamageMaxDepth;
+    G4double fDisplacementEnergy;
+    G4String fDamageFileName;
+
+    // Scattering distributions of a reference run, kept on the master and
+    // compared with later runs; set through /thesis/bench/
+    G4GenericMessenger* fBenchMessenger;
+    G4bool fStoreReference;
+    std::vector<G4double> fReferenceAngle;
+    std::vector<G4double> fReferenceEnergy;
+
+    G4Timer fTimer;
+
+    // Geometry re-initialization times of a rebuilt geometry, in seconds
+    // since the start of Construct(), measured on the master
+    G4bool fReportReinit;
+    G4double fReinitMasterTime;
+    G4double fReinitValidationTime;
+};
+
+#endif
@@ -0,0 +1,146 @@
+#include "stacking.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4AffineTransform.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VSolid.hh"
+#include "G4UIparameter.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+#include <sstream>
+
+MyStackingMessenger::MyStackingMessenger(MyStackingAction* stackingAction)
+    : G4UImessenger(),
+      fStackingAction(stackingAction)
+{
+    fKillBelowCmd = new G4UIcommand("/thesis/stack/killBelow", this);
+    fKillBelowCmd->SetGuidance("Kill secondaries of a species below a kinetic energy, e.g. e- 1 keV");
+
+    G4UIparameter* particleParameter = new G4UIparameter("particle", 's', false);
+    fKillBelowCmd->SetParameter(particleParameter);
+
+    G4UIparameter* energyParameter = new G4UIparameter("energy", 'd', false);
+    energyParameter->SetParameterRange("energy >= 0.");
+    fKillBelowCmd->SetParameter(energyParameter);
+
+    G4UIparameter* unitParameter = new G4UIparameter("unit", 's', false);
+    unitParameter->SetParameterCandidates(G4UIcommand::UnitsList("Energy"));
+    fKillBelowCmd->SetParameter(unitParameter);
+}
+
+MyStackingMessenger::~MyStackingMessenger()
+{
+    delete fKillBelowCmd;
+}
+
+void MyStackingMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == fKillBelowCmd) {
+        // The UI manager has already checked the range and the unit
+        std::istringstream is(newValue);
+        G4String particleName, unit;
+        G4double energy = 0.;
+        is >> particleName >> energy >> unit;
+        fStackingAction->SetKillBelow(particleName, energy * G4UIcommand::ValueOf(unit));
+    }
+}
+
+MyStackingAction::MyStackingAction(MyRunAction* runAction)
+    : G4UserStackingAction(),
+      fRunAction(runAction),
+      fMessenger(nullptr),
+      fStackingMessenger(nullptr),
+      fCullOutsideAcceptance(false),
+      fDetector(nullptr)
+{
+    DefineCommands();
+}
+
+MyStackingAction::~MyStackingAction()
+{
+    delete fMessenger;
+    delete fStackingMessenger;
+}
+
+G4ClassificationOfNewTrack MyStackingAction::ClassifyNewTrack(const G4Track* track)
+{
+    // Primaries are only culled after leaving the foil (see MySteppingAction)
+    if (track->GetParentID() == 0) {
+        return fUrgent;
+    }
+
+    const G4String& particleName = track->GetDefinition()->GetParticleName();
+
+    auto killBelow = fKillBelow.find(particleName);
+    if (killBelow != fKillBelow.end() && track->GetKineticEnergy() < killBelow->second) {
+        fRunAction->AddKilledSecondary();
+        return fKill;
+    }
+
+    // Secondaries born in the vacuum (world) travel in a straight line. Those
+    // born in the reflector are checked when they leave it (MySteppingAction)
+    if (fCullOutsideAcceptance) {
+        const G4VPhysicalVolume* volume = track->GetVolume();
+        if (volume && !volume->GetMotherLogical()
+            && !CanReachDetector(track->GetPosition(), track->GetMomentumDirection())) {
+            fRunAction->AddCulledSecondary();
+            return fKill;
+        }
+    }
+
+    if (fDeferred.count(particleName)) {
+        fRunAction->AddDeferredSecondary();
+        return fWaiting;
+    }
+
+    return fUrgent;
+}
+
+void MyStackingAction::PrepareNewEvent()
+{
+    // Looked up per event so a rebuilt geometry is picked up
+    fDetector = G4PhysicalVolumeStore::GetInstance()->GetVolume("physDetector", false);
+}
+
+G4bool MyStackingAction::CanReachDetector(const G4ThreeVector& pos, const G4ThreeVector& dir) const
+{
+    if (!fDetector) {
+        return true;
+    }
+
+    // Move into the detector frame and ask the solid for the distance along dir
+    G4AffineTransform toLocal(fDetector->GetRotation(), fDetector->GetTranslation());
+    toLocal.Invert();
+    G4ThreeVector localPos = toLocal.TransformPoint(pos);
+    G4ThreeVector localDir = toLocal.TransformAxis(dir);
+
+    const G4VSolid* solid = fDetector->GetLogicalVolume()->GetSolid();
+    return solid->DistanceToIn(localPos, localDir) != kInfinity;
+}
+
+void MyStackingAction::SetDeferred(const G4String& particleName)
+{
+    fDeferred.insert(particleName);
+}
+
+void MyStackingAction::ClearPolicies()
+{
+    fKillBelow.clear();
+    fDeferred.clear();
+    fCullOutsideAcceptance = false;
+}
+
+void MyStackingAction::DefineCommands()
+{
+    fMessenger = new G4GenericMessenger(this, "/thesis/stack/", "Track culling in the stacking action");
+
+    fMessenger->DeclareMethod("defer", &MyStackingAction::SetDeferred,
+        "Move secondaries of a species to the waiting stack");
+
+    fMessenger->DeclareProperty("cullOutsideAcceptance", fCullOutsideAcceptance,
+        "Kill tracks in the vacuum whose straight line misses the detector");
+
+    fMessenger->DeclareMethod("clear", &MyStackingAction::ClearPolicies,
+        "Remove all culling policies");
+
+    fStackingMessenger = new MyStackingMessenger(this);
+}
@@ -0,0 +1,74 @@
+#ifndef STACKING_HH
+#define STACKING_HH
+
+#include "G4UserStackingAction.hh"
+#include "G4GenericMessenger.hh"
+#include "G4UImessenger.hh"
+#include "G4UIcommand.hh"
+#include "G4ThreeVector.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4Track.hh"
+
+#include <map>
+#include <set>
+
+#include "run.hh"
+
+class MyStackingAction;
+
+// /thesis/stack/killBelow takes three parameters, which G4GenericMessenger
+// cannot pass to a method, so it has its own messenger
+class MyStackingMessenger : public G4UImessenger
+{
+public:
+    MyStackingMessenger(MyStackingAction*);
+    ~MyStackingMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+private:
+    MyStackingAction* fStackingAction;
+    G4UIcommand* fKillBelowCmd;
+};
+
+// Culls tracks that cannot contribute to the detector:
+//  - secondaries of a species below a kinetic energy threshold are killed
+//  - secondaries of a deferred species are moved to the waiting stack
+//  - tracks in the vacuum whose straight line misses the detector are killed:
+//    secondaries born in the world here, primaries and secondaries leaving
+//    the reflecting element in MySteppingAction
+// All policies are off by default and configured through /thesis/stack/.
+class MyStackingAction : public G4UserStackingAction
+{
+public:
+    MyStackingAction(MyRunAction*);
+    ~MyStackingAction();
+
+    virtual G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track*);
+    virtual void PrepareNewEvent();
+
+    G4bool IsAcceptanceCullingEnabled() const { return fCullOutsideAcceptance; }
+
+    // Kill secondaries of a species below a kinetic energy
+    void SetKillBelow(const G4String& particleName, G4double energy) { fKillBelow[particleName] = energy; }
+
+    // True if a straight line from pos along dir intersects the detector
+    G4bool CanReachDetector(const G4ThreeVector& pos, const G4ThreeVector& dir) const;
+
+private:
+    void SetDeferred(const G4String&);
+    void ClearPolicies();
+    void DefineCommands();
+
+    MyRunAction* fRunAction;
+    G4GenericMessenger* fMessenger;
+    MyStackingMessenger* fStackingMessenger;
+
+    std::map<G4String, G4double> fKillBelow;
+    std::set<G4String> fDeferred;
+    G4bool fCullOutsideAcceptance;
+
+    G4VPhysicalVolume* fDetector;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#include "stepping.hh"
+#include "G4Track.hh"
+#include "G4StepPoint.hh"
+#include "G4VPhysicalVolume.hh"
+
+MySteppingAction::MySteppingAction(MyRunAction* runAction, MyEventAction* eventAction, MyStackingAction* stackingAction,
+                                   const MyDetectorConstruction* detectorConstruction)
+    : G4UserSteppingAction(),
+      fRunAction(runAction),
+      fEventAction(eventAction),
+      fStackingAction(stackingAction),
+      fDetectorConstruction(detectorConstruction)
+{}
+
+MySteppingAction::~MySteppingAction()
+{}
+
+void MySteppingAction::UserSteppingAction(const G4Step* step)
+{
+    G4Track* track = step->GetTrack();
+
+    const G4VPhysicalVolume* preVolume = step->GetPreStepPoint()->GetPhysicalVolume();
+    G4bool inReflector = fDetectorConstruction->IsReflectorVolume(preVolume->GetLogicalVolume());
+    fEventAction->AddStep(inReflector);
+
+    if (inReflector) {
+        // Both ends in the frame of the volume the step was taken in
+        const G4VTouchable* touchable = step->GetPreStepPoint()->GetTouchable();
+        fRunAction->AddDepthDeposit(
+            fDetectorConstruction->GetDepthBelowSurface(touchable, step->GetPreStepPoint()->GetPosition()),
+            fDetectorConstruction->GetDepthBelowSurface(touchable, step->GetPostStepPoint()->GetPosition()),
+            step->GetTotalEnergyDeposit(), step->GetNonIonizingEnergyDeposit());
+    }
+
+    // Only look at tracks crossing from the reflecting element into the vacuum
+    G4StepPoint* postStepPoint = step->GetPostStepPoint();
+    if (!inReflector || postStepPoint->GetStepStatus() != fGeomBoundary) {
+        return;
+    }
+
+    const G4VPhysicalVolume* postVolume = postStepPoint->GetPhysicalVolume();
+    if (!postVolume || postVolume->GetMotherLogical()) {
+        return;
+    }
+
+    G4bool primary = (track->GetParentID() == 0);
+    if (primary) {
+        fRunAction->AddReflectorExit(postStepPoint->GetMomentumDirection(),
+                                     postStepPoint->GetKineticEnergy() / track->GetVertexKineticEnergy());
+    }
+
+    // Delta electrons and other secondaries from the foil are culled here too
+    if (fStackingAction->IsAcceptanceCullingEnabled()
+        && !fStackingAction->CanReachDetector(postStepPoint->GetPosition(), postStepPoint->GetMomentumDirection())) {
+        track->SetTrackStatus(fStopAndKill);
+        if (primary) {
+            fRunAction->AddCulledPrimary();
+        } else {
+            fRunAction->AddCulledSecondary();
+        }
+    }
+}
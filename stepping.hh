@@ -0,0 +1,27 @@
+#ifndef STEPPING_HH
+#define STEPPING_HH
+
+#include "G4UserSteppingAction.hh"
+#include "G4Step.hh"
+
+#include "run.hh"
+#include "event.hh"
+#include "stacking.hh"
+#include "construction.hh"
+
+class MySteppingAction : public G4UserSteppingAction
+{
+public:
+    MySteppingAction(MyRunAction*, MyEventAction*, MyStackingAction*, const MyDetectorConstruction*);
+    ~MySteppingAction();
+
+    virtual void UserSteppingAction(const G4Step*);
+
+private:
+    MyRunAction* fRunAction;
+    MyEventAction* fEventAction;
+    MyStackingAction* fStackingAction;
+    const MyDetectorConstruction* fDetectorConstruction;
+};
+
+#endif
@@ -0,0 +1,196 @@
+#include "telemetry.hh"
+#include "G4SystemOfUnits.hh"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+MyTelemetry* MyTelemetry::Instance()
+{
+    // Never deleted: the writer is joined in StopRun and the messenger must
+    // not outlive the UI manager at exit
+    static MyTelemetry* instance = new MyTelemetry();
+    return instance;
+}
+
+MyTelemetry::MyTelemetry()
+    : fMessenger(nullptr),
+      fEnabled(true),
+      fFileName("telemetry.jsonl"),
+      fInterval(1. * s),
+      fEventsDone(0),
+      fSteps(0),
+      fHits(0),
+      fRunInterval(1. * s),
+      fRunID(0),
+      fTotalEvents(0),
+      fLastEvents(0),
+      fLastSteps(0),
+      fRunning(false)
+{
+    fMessenger = new G4GenericMessenger(this, "/thesis/telemetry/", "Live run telemetry");
+
+    fMessenger->DeclareProperty("enable", fEnabled,
+        "Write periodic run snapshots");
+
+    fMessenger->DeclareProperty("fileName", fFileName,
+        "File the snapshots are appended to (one JSON object per line)");
+
+    fMessenger->DeclarePropertyWithUnit("interval", "s", fInterval,
+        "Time between snapshots");
+
+    fMessenger->DeclareMethod("sweepPoint", &MyTelemetry::SetSweepPoint,
+        "Label of the current sweep point, e.g. thickness=0.5um");
+}
+
+MyTelemetry::~MyTelemetry()
+{
+    StopRun();
+    delete fMessenger;
+}
+
+void MyTelemetry::StartRun(G4int runID, G4int totalEvents)
+{
+    StopRun();
+    if (!fEnabled) {
+        return;
+    }
+
+    fEventsDone.store(0, std::memory_order_relaxed);
+    fSteps.store(0, std::memory_order_relaxed);
+    fHits.store(0, std::memory_order_relaxed);
+    fRunID = runID;
+    fTotalEvents = totalEvents;
+    fRunStart = std::chrono::steady_clock::now();
+    fLastSnapshot = fRunStart;
+    fLastEvents = 0;
+    fLastSteps = 0;
+    fRunFileName = fFileName;
+    fRunInterval = fInterval;
+
+    // Start a fresh file once per process, later runs (sweep points) append
+    if (fRunFileName != fStartedFileName) {
+        std::ofstream outFile(fRunFileName, std::ios::trunc);
+        fStartedFileName = fRunFileName;
+    }
+
+    fRunning = true;
+    fWriter = std::thread(&MyTelemetry::WriterLoop, this);
+}
+
+void MyTelemetry::StopRun()
+{
+    if (!fWriter.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(fWakeMutex);
+        fRunning = false;
+    }
+    fWake.notify_all();
+    fWriter.join();
+
+    WriteSnapshot(true);
+}
+
+void MyTelemetry::SetSweepPoint(const G4String& label)
+{
+    std::lock_guard<std::mutex> lock(fSweepMutex);
+    fSweepPoint = label;
+}
+
+void MyTelemetry::WriterLoop()
+{
+    auto interval = std::chrono::duration<G4double>(std::max(fRunInterval / s, 0.01));
+
+    std::unique_lock<std::mutex> lock(fWakeMutex);
+    while (fRunning) {
+        if (fWake.wait_for(lock, interval, [this] { return !fRunning; })) {
+            break;
+        }
+        lock.unlock();
+        WriteSnapshot(false);
+        lock.lock();
+    }
+}
+
+void MyTelemetry::WriteSnapshot(G4bool final)
+{
+    auto now = std::chrono::steady_clock::now();
+    G4double elapsed = std::chrono::duration<G4double>(now - fRunStart).count();
+    G4double sinceLast = std::chrono::duration<G4double>(now - fLastSnapshot).count();
+
+    G4long events = fEventsDone.load(std::memory_order_relaxed);
+    G4long steps = fSteps.load(std::memory_order_relaxed);
+    G4long hits = fHits.load(std::memory_order_relaxed);
+
+    // Rates over the last interval, ETA from the average rate of the run
+    G4double eventRate = sinceLast > 0. ? (events - fLastEvents) / sinceLast : 0.;
+    G4double stepRate = sinceLast > 0. ? (steps - fLastSteps) / sinceLast : 0.;
+    G4double eta = -1.;
+    if (events > 0) {
+        eta = std::max(fTotalEvents - events, G4long(0)) * elapsed / events;
+    }
+
+    fLastSnapshot = now;
+    fLastEvents = events;
+    fLastSteps = steps;
+
+    G4String sweepPoint;
+    {
+        std::lock_guard<std::mutex> lock(fSweepMutex);
+        sweepPoint = fSweepPoint;
+    }
+
+    std::ostringstream os;
+    os << "{\"run\":" << fRunID
+       << ",\"final\":" << (final ? "true" : "false")
+       << ",\"elapsed_s\":" << elapsed
+       << ",\"events_done\":" << events
+       << ",\"events_total\":" << fTotalEvents
+       << ",\"events_per_s\":" << eventRate
+       << ",\"steps_per_s\":" << stepRate
+       << ",\"hits_accepted\":" << hits
+       << ",\"sweep_point\":\"" << EscapeJson(sweepPoint) << "\""
+       << ",\"rss_mb\":" << GetResidentMemoryMB()
+       << ",\"eta_s\":" << eta
+       << "}\n";
+
+    std::ofstream outFile(fRunFileName, std::ios::app);
+    outFile << os.str();
+}
+
+G4String MyTelemetry::EscapeJson(const G4String& value)
+{
+    std::string escaped;
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[7];
+            std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned char>(c));
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+G4double MyTelemetry::GetResidentMemoryMB()
+{
+#ifdef __linux__
+    // Second field of statm is the resident set size in pages
+    std::ifstream statm("/proc/self/statm");
+    long size = 0, resident = 0;
+    if (statm >> size >> resident) {
+        return resident * G4double(sysconf(_SC_PAGESIZE)) / (1024. * 1024.);
+    }
+#endif
+    return 0.;
+}
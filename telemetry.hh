@@ -0,0 +1,75 @@
+#ifndef TELEMETRY_HH
+#define TELEMETRY_HH
+
+#include "globals.hh"
+#include "G4GenericMessenger.hh"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Live run telemetry. Worker threads only touch relaxed atomic counters;
+// a writer thread on the master appends a JSON snapshot per interval to a
+// local file (one object per line) that a dashboard can tail.
+// Configured through /thesis/telemetry/.
+class MyTelemetry
+{
+public:
+    static MyTelemetry* Instance();
+
+    // Called by the master run action around the event loop
+    void StartRun(G4int runID, G4int totalEvents);
+    void StopRun();
+
+    // Called from the event loop, lock free
+    void AddEvent(G4long steps)
+    {
+        fEventsDone.fetch_add(1, std::memory_order_relaxed);
+        fSteps.fetch_add(steps, std::memory_order_relaxed);
+    }
+    void AddHit() { fHits.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    MyTelemetry();
+    ~MyTelemetry();
+
+    void SetSweepPoint(const G4String&);
+    void WriterLoop();
+    void WriteSnapshot(G4bool final);
+    static G4double GetResidentMemoryMB();
+    static G4String EscapeJson(const G4String&);
+
+    G4GenericMessenger* fMessenger;
+    G4bool fEnabled;
+    G4String fFileName;
+    G4double fInterval;
+
+    std::atomic<G4long> fEventsDone;
+    std::atomic<G4long> fSteps;
+    std::atomic<G4long> fHits;
+
+    // Only used by the master and the writer thread. The file name and
+    // interval are copied at the start of a run, the UI may change the
+    // settings while the writer is running
+    G4String fRunFileName;
+    G4double fRunInterval;
+    G4String fStartedFileName;
+    G4int fRunID;
+    G4int fTotalEvents;
+    std::chrono::steady_clock::time_point fRunStart;
+    std::chrono::steady_clock::time_point fLastSnapshot;
+    G4long fLastEvents;
+    G4long fLastSteps;
+
+    std::mutex fSweepMutex;
+    G4String fSweepPoint;
+
+    std::thread fWriter;
+    std::mutex fWakeMutex;
+    std::condition_variable fWake;
+    G4bool fRunning;
+};
+
+#endif
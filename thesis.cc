@@ -43,9 +43,10 @@ int main(int argc, char** argv) {
     G4RunManager* runManager = new G4RunManager();
     #endif
 
-    runManager->SetUserInitialization(new MyDetectorConstruction());
+    MyDetectorConstruction* detectorConstruction = new MyDetectorConstruction();
+    runManager->SetUserInitialization(detectorConstruction);
     runManager->SetUserInitialization(new MyPhysicsList());
-    runManager->SetUserInitialization(new MyActionInitialization());
+    runManager->SetUserInitialization(new MyActionInitialization(detectorConstruction));
 
     runManager->Initialize();
 
@@ -58,18 +59,8 @@ int main(int argc, char** argv) {
 
     UImanager->ApplyCommand("/tracking/verbose 1"); // Enable verbose tracking
 
-    // // Redirect G4cout to a file
-    // std::ofstream overlapFile("overlap_check.log");
-    // std::streambuf* oldBuffer = G4cout.rdbuf(); // Save the old buffer
-    // G4cout.rdbuf(overlapFile.rdbuf());          // Redirect G4cout to the file
-
-    // // Check for overlaps
-    // UImanager->ApplyCommand("/geometry/test/recursive_world 1");
-    // UImanager->ApplyCommand("/geometry/test/run");
-
-    // // Restore G4cout to its original state
-    // G4cout.rdbuf(oldBuffer);
-    // overlapFile.close();
+    // Overlaps are checked at the start of the first run after each
+    // (re)build, see MyOverlapValidator and /thesis/overlaps/
 
     UImanager->ApplyCommand("/vis/open OGL");
     UImanager->ApplyCommand("/vis/viewer/set/viewpointVector 1 1 1");